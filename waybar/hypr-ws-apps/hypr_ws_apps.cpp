@@ -3,17 +3,28 @@
 #include <glib.h>
 #include <json-glib/json-glib.h>
 
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
 #include <sys/socket.h>
+#include <sys/time.h>
 #include <sys/un.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <atomic>
+#include <cerrno>
+#include <csignal>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <optional>
 #include <mutex>
@@ -30,19 +41,6 @@ static std::string getenv_str(const char* k) {
   const char* v = std::getenv(k);
   return v ? std::string(v) : std::string();
 }
-static std::string run_cmd_capture(const char* cmd) {
-  std::string out;
-  FILE* fp = popen(cmd, "r");
-  if (!fp) return out;
-  char buf[4096];
-  while (true) {
-    size_t n = fread(buf, 1, sizeof(buf), fp);
-    if (n == 0) break;
-    out.append(buf, buf + n);
-  }
-  pclose(fp);
-  return out;
-}
 static std::string trim(std::string s) {
   while (!s.empty() && (s.back()=='\n' || s.back()=='\r' || s.back()==' ' || s.back()=='\t')) s.pop_back();
   size_t i=0;
@@ -70,6 +68,272 @@ static std::string normalize_class_name(const std::string& s) {
   return out;
 }
 
+// ---------- tracing ----------
+// Opt-in Chrome trace (chrome://tracing, ui.perfetto.dev) of where update time goes.
+// Each thread writes to its own ring of the most recent events and publishes with a release
+// store, so recording never locks; with tracing off a span costs one relaxed atomic load.
+struct TraceEvent {
+  const char* name; // string literal
+  gint64 ts;        // µs, g_get_monotonic_time()
+  gint64 dur;       // µs
+  int label;        // index into Tracer::labels, -1 if none
+};
+
+// Ring slot. Fields are atomics (relaxed) because trace_write may read a slot while its
+// thread overwrites it; such slots are detected and discarded, but must not be a data race.
+struct TraceSlot {
+  std::atomic<const char*> name{nullptr};
+  std::atomic<gint64> ts{0};
+  std::atomic<gint64> dur{0};
+  std::atomic<int> label{-1};
+};
+
+struct TraceBuffer {
+  static constexpr size_t kCapacity = 1 << 16; // most recent events kept per thread
+  std::unique_ptr<TraceSlot[]> events{new TraceSlot[kCapacity]};
+  std::atomic<uint64_t> written{0}; // total ever recorded; slot = index % kCapacity
+  int tid = 0;
+  std::string thread_name;
+};
+
+struct Tracer {
+  std::atomic<bool> enabled{false};
+  std::mutex mu; // guards everything below; never taken while recording
+  std::string path;
+  std::vector<std::shared_ptr<TraceBuffer>> buffers; // outlive their threads until written
+  std::vector<std::pair<std::string, std::string>> labels; // (instance, workspace)
+};
+
+static Tracer g_tracer;
+static thread_local std::shared_ptr<TraceBuffer> t_trace_buf;
+static thread_local int t_trace_label = -1;
+
+static void trace_enable(const std::string& path) {
+  std::lock_guard<std::mutex> lk(g_tracer.mu);
+  if (g_tracer.enabled.load()) return; // first instance to ask picks the file
+  g_tracer.path = path;
+  g_tracer.enabled.store(true);
+  g_message("hypr-ws-apps: tracing to %s", path.c_str());
+}
+
+// Registered even with tracing off: a later instance's trace_file may still turn it on
+static int trace_register_label(const std::string& instance, const std::string& workspace) {
+  std::lock_guard<std::mutex> lk(g_tracer.mu);
+  g_tracer.labels.emplace_back(instance, workspace);
+  return (int)g_tracer.labels.size() - 1;
+}
+
+static void trace_record(const char* name, gint64 ts, gint64 dur) {
+  if (!t_trace_buf) {
+    // First event on this thread: register its buffer (once per thread)
+    auto buf = std::make_shared<TraceBuffer>();
+    char tname[16] = "";
+    pthread_getname_np(pthread_self(), tname, sizeof(tname));
+    buf->thread_name = tname;
+    std::lock_guard<std::mutex> lk(g_tracer.mu);
+    buf->tid = (int)g_tracer.buffers.size() + 1;
+    g_tracer.buffers.push_back(buf);
+    t_trace_buf = std::move(buf);
+  }
+  TraceBuffer& b = *t_trace_buf;
+  uint64_t n = b.written.load(std::memory_order_relaxed);
+  TraceSlot& slot = b.events[n % TraceBuffer::kCapacity];
+  // Pairs with the acquire fence in trace_write: a reader that sees any of these stores also
+  // sees written >= n, and so discards this slot
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.ts.store(ts, std::memory_order_relaxed);
+  slot.dur.store(dur, std::memory_order_relaxed);
+  slot.label.store(t_trace_label, std::memory_order_relaxed);
+  b.written.store(n + 1, std::memory_order_release);
+}
+
+// RAII span, recorded as a complete ("X") event when it goes out of scope
+struct TraceSpan {
+  const char* name;
+  gint64 start = 0;
+  explicit TraceSpan(const char* n) : name(n) {
+    if (g_tracer.enabled.load(std::memory_order_relaxed)) start = g_get_monotonic_time();
+  }
+  ~TraceSpan() {
+    if (start) trace_record(name, start, g_get_monotonic_time() - start);
+  }
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+// Tags every span recorded on this thread while in scope with an instance/workspace label
+struct TraceLabelScope {
+  int prev;
+  explicit TraceLabelScope(int label) : prev(t_trace_label) { t_trace_label = label; }
+  ~TraceLabelScope() { t_trace_label = prev; }
+  TraceLabelScope(const TraceLabelScope&) = delete;
+  TraceLabelScope& operator=(const TraceLabelScope&) = delete;
+};
+
+static std::string json_escape(std::string_view s) {
+  std::string out;
+  for (char c : s) {
+    if (c == '"' || c == '\\') { out += '\\'; out += c; }
+    else if ((unsigned char)c < 0x20) { char buf[8]; snprintf(buf, sizeof(buf), "\\u%04x", c); out += buf; }
+    else out += c;
+  }
+  return out;
+}
+
+// Writes the most recent events of every thread (the file is rewritten, not appended). Safe
+// while other threads keep recording: slots are copied, then any the writer may have lapped
+// during the copy are discarded.
+static void trace_write() {
+  if (!g_tracer.enabled.load()) return;
+  std::lock_guard<std::mutex> lk(g_tracer.mu);
+
+  std::string tmp_path = g_tracer.path + ".tmp";
+  FILE* fp = fopen(tmp_path.c_str(), "w");
+  if (!fp) {
+    g_warning("hypr-ws-apps: cannot write trace to %s", tmp_path.c_str());
+    return;
+  }
+
+  const int pid = (int)getpid();
+  bool first = true;
+  fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", fp);
+  for (const auto& b : g_tracer.buffers) {
+    fprintf(fp, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+            first ? "" : ",", pid, b->tid, json_escape(b->thread_name).c_str());
+    first = false;
+
+    uint64_t end = b->written.load(std::memory_order_acquire);
+    uint64_t begin = end > TraceBuffer::kCapacity ? end - TraceBuffer::kCapacity : 0;
+    std::vector<TraceEvent> copy;
+    copy.reserve(end - begin);
+    for (uint64_t i = begin; i < end; i++) {
+      const TraceSlot& slot = b->events[i % TraceBuffer::kCapacity];
+      copy.push_back(TraceEvent{slot.name.load(std::memory_order_relaxed), slot.ts.load(std::memory_order_relaxed),
+                                slot.dur.load(std::memory_order_relaxed), slot.label.load(std::memory_order_relaxed)});
+    }
+    // Slots older than the last kCapacity writes, plus the one a write may be in progress on
+    // (index `now`), may have been overwritten while copying
+    std::atomic_thread_fence(std::memory_order_acquire);
+    uint64_t now = b->written.load(std::memory_order_relaxed);
+    uint64_t oldest_valid = now + 1 > TraceBuffer::kCapacity ? now + 1 - TraceBuffer::kCapacity : 0;
+    size_t skip = oldest_valid > begin ? (size_t)std::min<uint64_t>(oldest_valid - begin, copy.size()) : 0;
+
+    for (size_t i = skip; i < copy.size(); i++) {
+      const TraceEvent& e = copy[i];
+      fprintf(fp, ",\n{\"name\":\"%s\",\"cat\":\"hypr-ws-apps\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":%d,\"tid\":%d",
+              e.name, (long long)e.ts, (long long)e.dur, pid, b->tid);
+      if (e.label >= 0 && (size_t)e.label < g_tracer.labels.size()) {
+        const auto& [instance, workspace] = g_tracer.labels[e.label];
+        fprintf(fp, ",\"args\":{\"instance\":\"%s\",\"workspace\":\"%s\"}",
+                json_escape(instance).c_str(), json_escape(workspace).c_str());
+      }
+      fputc('}', fp);
+    }
+  }
+  fputs("\n]}\n", fp);
+
+  if (fclose(fp) != 0 || rename(tmp_path.c_str(), g_tracer.path.c_str()) != 0) {
+    g_warning("hypr-ws-apps: cannot write trace to %s", g_tracer.path.c_str());
+  }
+}
+
+// ---------- hypr IPC ----------
+static std::string hypr_socket_path(const char* name) {
+  std::string runtime = getenv_str("XDG_RUNTIME_DIR");
+  std::string sig = getenv_str("HYPRLAND_INSTANCE_SIGNATURE");
+  if (runtime.empty() || sig.empty()) return std::string();
+  return runtime + "/hypr/" + sig + "/" + name;
+}
+
+// One request/reply round-trip on the control socket (what hyprctl does, minus the fork)
+static std::string hypr_request(const std::string& request) {
+  TraceSpan span("ipc query");
+  std::string out;
+  std::string sock_path = hypr_socket_path(".socket.sock");
+  if (sock_path.empty()) return out;
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0) return out;
+
+  // Called on the GTK thread: a stalled Hyprland may cost a frame drop, never a frozen bar
+  timeval timeout{1, 0};
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, sock_path.c_str(), sizeof(addr.sun_path) - 1);
+  if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) { close(fd); return out; }
+
+  size_t off = 0;
+  while (off < request.size()) {
+    ssize_t n = send(fd, request.data() + off, request.size() - off, MSG_NOSIGNAL);
+    if (n <= 0) { close(fd); return out; }
+    off += (size_t)n;
+  }
+
+  // Hyprland closes the connection once the reply is written
+  char buf[8192];
+  while (true) {
+    ssize_t n = read(fd, buf, sizeof(buf));
+    if (n <= 0) break;
+    out.append(buf, buf + n);
+  }
+  close(fd);
+  return out;
+}
+
+// Splits a [[BATCH]] reply into one reply per command. Hyprland concatenates them, with or
+// without blank lines in between depending on the version, so a leading "ok" is one reply
+// and anything else runs up to the next blank line (the last command gets the remainder).
+static std::vector<std::string> split_batch_reply(const std::string& reply, size_t count) {
+  std::vector<std::string> out;
+  size_t pos = 0;
+  for (size_t i = 0; i < count; i++) {
+    while (pos < reply.size() && g_ascii_isspace(reply[pos])) pos++;
+    if (pos >= reply.size()) { out.emplace_back(); continue; }
+
+    size_t end = reply.size();
+    if (reply.compare(pos, 2, "ok") == 0 && i + 1 < count) {
+      end = pos + 2;
+    } else if (i + 1 < count) {
+      size_t blank = reply.find("\n\n", pos);
+      if (blank != std::string::npos) end = blank;
+    }
+    out.push_back(trim(reply.substr(pos, end - pos)));
+    pos = end;
+  }
+  return out;
+}
+
+// Sends all dispatchers as a single [[BATCH]] request: one connection, one reply
+static bool hypr_dispatch_batch(const std::vector<std::string>& dispatches) {
+  if (dispatches.empty()) return true;
+
+  std::string req = "[[BATCH]]";
+  for (const auto& d : dispatches) {
+    req += "dispatch ";
+    req += d;
+    req += ';';
+  }
+
+  // Every dispatcher answers "ok"; anything else is an error message worth logging
+  std::string reply = hypr_request(req);
+  if (reply.empty()) {
+    g_warning("hypr-ws-apps: dispatch failed (no reply): %s", req.c_str());
+    return false;
+  }
+  auto replies = split_batch_reply(reply, dispatches.size());
+  bool ok = true;
+  for (size_t i = 0; i < dispatches.size(); i++) {
+    if (replies[i] == "ok") continue;
+    g_warning("hypr-ws-apps: dispatch %s failed: %s", dispatches[i].c_str(), replies[i].c_str());
+    ok = false;
+  }
+  return ok;
+}
+
 // ---------- icon resolver (unchanged logic, shortened here if you want) ----------
 struct DesktopEntry {
   std::string path, icon, startup_wmclass, name;
@@ -144,15 +408,74 @@ static std::string stem_of_desktop(const std::string& path) {
   return base;
 }
 
+// File path for an Icon= value naming a file (absolute or file://), empty for theme icon names
+static std::string icon_file_path(const std::string& icon) {
+  if (starts_with(icon, "file://")) return icon.substr(7);
+  if (!icon.empty() && icon[0] == '/') return icon;
+  return std::string();
+}
+
 struct IconResolver {
   std::mutex mu;
-  std::vector<std::string> desktop_files{list_desktop_files()};
+  std::shared_ptr<const std::vector<std::string>> desktop_files; // null: scan on next resolve
   std::unordered_map<std::string, std::string> class_to_icon;
+  std::unordered_map<std::string, GdkPixbuf*> pixbufs; // "path@size" -> pixbuf (null: failed)
+  std::unordered_set<std::string> prefetch_queued;      // "class@size" already handed to the pool
+  GThreadPool* prefetch_pool = nullptr;
+  uint64_t generation = 0; // bumped by release(); resolves started before it are not cached
+  int users = 0;           // live module instances
+
+  void acquire() {
+    std::lock_guard<std::mutex> lk(mu);
+    users++;
+  }
+
+  // Last instance gone (Waybar config reload): forget misses and rescan .desktop files on next
+  // use, so apps installed since Waybar started get their icons. Hits stay cached.
+  void release() {
+    std::lock_guard<std::mutex> lk(mu);
+    if (--users > 0) return;
+    generation++;
+    desktop_files.reset();
+    std::erase_if(class_to_icon, [](const auto& kv) { return kv.second.empty(); });
+    std::erase_if(pixbufs, [](const auto& kv) { return kv.second == nullptr; });
+    prefetch_queued.clear();
+  }
+
+  // Returns a new reference to the decoded icon, decoding only on the first request
+  GdkPixbuf* load_pixbuf(const std::string& path, int size) {
+    std::string key = path + "@" + std::to_string(size);
+    {
+      std::lock_guard<std::mutex> lk(mu);
+      auto it = pixbufs.find(key);
+      if (it != pixbufs.end()) return it->second ? (GdkPixbuf*)g_object_ref(it->second) : nullptr;
+    }
+
+    GdkPixbuf* pb;
+    {
+      TraceSpan decode("pixbuf decode");
+      pb = gdk_pixbuf_new_from_file_at_scale(path.c_str(), size, size, TRUE, nullptr);
+    }
+
+    std::lock_guard<std::mutex> lk(mu);
+    auto [it, inserted] = pixbufs.emplace(key, pb);
+    if (!inserted) { // another thread decoded it meanwhile
+      if (pb) g_object_unref(pb);
+      pb = it->second;
+    }
+    return pb ? (GdkPixbuf*)g_object_ref(pb) : nullptr;
+  }
+
+  // Resolves `cls` (and decodes a file icon) on a background thread at idle priority, so
+  // the first render showing this app hits warm caches. No-op for classes already queued.
+  void prefetch(const std::string& cls, int size, int trace_label);
 
   std::optional<std::string> resolve_icon_for_class(const std::string& cls) {
     if (cls.empty()) return std::nullopt;
     std::string key = lower_ascii(cls);
 
+    std::shared_ptr<const std::vector<std::string>> files;
+    uint64_t gen;
     {
       std::lock_guard<std::mutex> lk(mu);
       auto it = class_to_icon.find(key);
@@ -160,12 +483,15 @@ struct IconResolver {
         if (it->second.empty()) return std::nullopt;
         return it->second;
       }
+      if (!desktop_files) desktop_files = std::make_shared<const std::vector<std::string>>(list_desktop_files());
+      files = desktop_files;
+      gen = generation;
     }
 
     std::optional<std::string> found;
 
     // Try direct match
-    for (const auto& f : desktop_files) {
+    for (const auto& f : *files) {
       if (lower_ascii(stem_of_desktop(f)) == key) {
         auto e = parse_desktop_file(f);
         if (!e.icon.empty()) { found = e.icon; break; }
@@ -173,7 +499,7 @@ struct IconResolver {
     }
     // Try StartupWMClass match
     if (!found) {
-      for (const auto& f : desktop_files) {
+      for (const auto& f : *files) {
         auto e = parse_desktop_file(f);
         if (!e.startup_wmclass.empty() && lower_ascii(e.startup_wmclass) == key) {
           if (!e.icon.empty()) { found = e.icon; break; }
@@ -184,14 +510,14 @@ struct IconResolver {
     // Fallback: try normalized class name (lowercase, dashes)
     if (!found) {
       std::string norm = normalize_class_name(cls);
-      for (const auto& f : desktop_files) {
+      for (const auto& f : *files) {
         if (lower_ascii(stem_of_desktop(f)) == norm) {
           auto e = parse_desktop_file(f);
           if (!e.icon.empty()) { found = e.icon; break; }
         }
       }
       if (!found) {
-        for (const auto& f : desktop_files) {
+        for (const auto& f : *files) {
           auto e = parse_desktop_file(f);
           if (!e.startup_wmclass.empty() && lower_ascii(e.startup_wmclass) == norm) {
             if (!e.icon.empty()) { found = e.icon; break; }
@@ -202,30 +528,126 @@ struct IconResolver {
 
     {
       std::lock_guard<std::mutex> lk(mu);
-      class_to_icon[key] = found.value_or("");
+      if (gen == generation) class_to_icon[key] = found.value_or("");
     }
     return found;
   }
 };
 
-// ---------- hypr clients ----------
-struct ClientInfo { std::string cls, title; };
+struct PrefetchJob {
+  std::string cls;
+  int size;
+  int trace_label; // of the instance that asked first
+};
 
-static std::vector<ClientInfo> clients_in_workspace(const std::string& workspace_id_or_name) {
-  std::vector<ClientInfo> out;
-  std::string json = trim(run_cmd_capture("hyprctl -j clients"));
-  if (json.empty()) return out;
+static IconResolver& shared_resolver() {
+  static IconResolver resolver; // one per process, shared by all module instances
+  return resolver;
+}
+
+struct ThemeWarmJob {
+  std::string icon;
+  int size;
+  int trace_label;
+};
+
+// GtkIconTheme is GTK-thread only, so theme icons are looked up there, at low priority,
+// leaving the first render showing the app a warm GTK icon cache
+static gboolean warm_theme_icon(gpointer data) {
+  std::unique_ptr<ThemeWarmJob> job((ThemeWarmJob*)data);
+  TraceLabelScope label(job->trace_label);
+  TraceSpan span("theme icon warm");
+  GtkIconTheme* theme = gtk_icon_theme_get_default();
+  if (gtk_icon_theme_has_icon(theme, job->icon.c_str())) {
+    GdkPixbuf* pb = gtk_icon_theme_load_icon(theme, job->icon.c_str(), job->size, (GtkIconLookupFlags)0, nullptr);
+    if (pb) g_object_unref(pb);
+  }
+  return G_SOURCE_REMOVE;
+}
+
+static void prefetch_worker(gpointer data, gpointer) {
+  std::unique_ptr<PrefetchJob> job((PrefetchJob*)data);
+
+  static thread_local bool idle_set = false;
+  if (!idle_set) {
+    sched_param param{};
+    pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+    idle_set = true;
+  }
+
+  TraceLabelScope label(job->trace_label);
+  TraceSpan span("icon prefetch");
+  IconResolver& r = shared_resolver();
+  auto icon = r.resolve_icon_for_class(job->cls);
+  if (!icon) return;
+  std::string path = icon_file_path(*icon);
+  if (!path.empty()) {
+    if (GdkPixbuf* pb = r.load_pixbuf(path, job->size)) g_object_unref(pb);
+  } else {
+    g_idle_add_full(G_PRIORITY_LOW, warm_theme_icon, new ThemeWarmJob{*icon, job->size, job->trace_label}, nullptr);
+  }
+}
+
+void IconResolver::prefetch(const std::string& cls, int size, int trace_label) {
+  if (cls.empty()) return;
+  std::lock_guard<std::mutex> lk(mu);
+  if (!prefetch_queued.insert(lower_ascii(cls) + "@" + std::to_string(size)).second) return;
+  if (!prefetch_pool) {
+    prefetch_pool = g_thread_pool_new(prefetch_worker, nullptr, 1, TRUE, nullptr);
+    if (!prefetch_pool) return;
+  }
+  g_thread_pool_push(prefetch_pool, new PrefetchJob{cls, size, trace_label}, nullptr);
+}
 
+// ---------- hypr clients ----------
+struct ClientInfo {
+  std::string address, cls, title;
+  int workspace_id = 0;
+  std::string workspace_name;
+};
+
+// Parses one JSON document and hands its root to `fn`; false if it does not parse
+template <typename Fn>
+static bool with_json_root(std::string_view json, Fn&& fn) {
+  TraceSpan span("json parse");
   JsonParser* parser = json_parser_new();
   GError* err = nullptr;
-  if (!json_parser_load_from_data(parser, json.c_str(), (gssize)json.size(), &err)) {
+  if (!json_parser_load_from_data(parser, json.data(), (gssize)json.size(), &err)) {
     if (err) g_error_free(err);
     g_object_unref(parser);
-    return out;
+    return false;
+  }
+  fn(json_parser_get_root(parser));
+  g_object_unref(parser);
+  return true;
+}
+
+// Splits a reply holding several concatenated JSON documents (a [[BATCH]] of j/ queries)
+// into the individual top-level objects/arrays. Anything between them is skipped.
+static std::vector<std::string_view> split_json_values(std::string_view buf) {
+  std::vector<std::string_view> out;
+  int depth = 0;
+  bool in_str = false, esc = false;
+  size_t begin = 0;
+  for (size_t i = 0; i < buf.size(); i++) {
+    char c = buf[i];
+    if (in_str) {
+      if (esc) esc = false;
+      else if (c == '\\') esc = true;
+      else if (c == '"') in_str = false;
+      continue;
+    }
+    if (depth == 0 && c != '{' && c != '[') continue;
+    if (c == '"') in_str = true;
+    else if (c == '{' || c == '[') { if (depth++ == 0) begin = i; }
+    else if ((c == '}' || c == ']') && --depth == 0) out.push_back(buf.substr(begin, i - begin + 1));
   }
+  return out;
+}
 
-  JsonNode* root = json_parser_get_root(parser);
-  if (!JSON_NODE_HOLDS_ARRAY(root)) { g_object_unref(parser); return out; }
+static std::vector<ClientInfo> parse_clients(JsonNode* root) {
+  std::vector<ClientInfo> out;
+  if (!root || !JSON_NODE_HOLDS_ARRAY(root)) return out;
 
   JsonArray* arr = json_node_get_array(root);
   guint n = json_array_get_length(arr);
@@ -237,28 +659,404 @@ static std::vector<ClientInfo> clients_in_workspace(const std::string& workspace
     JsonObject* ws = json_object_get_object_member(obj, "workspace");
     if (!ws) continue;
 
-    int ws_id = json_object_get_int_member(ws, "id");
     const char* ws_name = json_object_get_string_member(ws, "name");
-
-    bool match = false;
-    char buf[32]; snprintf(buf, sizeof(buf), "%d", ws_id);
-    if (workspace_id_or_name == buf) match = true;
-    if (ws_name && workspace_id_or_name == ws_name) match = true;
-    if (!match) continue;
-
+    const char* address = json_object_get_string_member(obj, "address");
     const char* cls = json_object_get_string_member(obj, "class");
     const char* title = json_object_get_string_member(obj, "title");
 
     ClientInfo ci;
+    ci.workspace_id = (int)json_object_get_int_member(ws, "id");
+    if (ws_name) ci.workspace_name = ws_name;
+    if (address) ci.address = address;
     if (cls) ci.cls = cls;
     if (title) ci.title = title;
     out.push_back(std::move(ci));
   }
+  return out;
+}
 
-  g_object_unref(parser);
+static std::vector<ClientInfo> clients_in_workspace(const std::vector<ClientInfo>& all,
+                                                    const std::string& workspace_id_or_name) {
+  std::vector<ClientInfo> out;
+  for (const auto& c : all) {
+    bool match = false;
+    char buf[32]; snprintf(buf, sizeof(buf), "%d", c.workspace_id);
+    if (workspace_id_or_name == buf) match = true;
+    if (!c.workspace_name.empty() && workspace_id_or_name == c.workspace_name) match = true;
+    if (match) out.push_back(c);
+  }
+  return out;
+}
+
+// nullopt when Hyprland could not be asked, as opposed to no windows at all
+static std::optional<std::vector<ClientInfo>> fetch_clients() {
+  std::vector<ClientInfo> out;
+  std::string json = hypr_request("j/clients");
+  if (!with_json_root(json, [&](JsonNode* root) { out = parse_clients(root); })) return std::nullopt;
+  return out;
+}
+
+// Everything the module needs to start correct, before any event arrives
+struct HyprSnapshot {
+  bool ok = false;
+  std::vector<ClientInfo> clients;
+  std::string active_workspace;
+  std::string active_special_workspace;
+};
+
+// Clients, active workspace and every monitor's special workspace in one batched round-trip
+static HyprSnapshot fetch_snapshot() {
+  HyprSnapshot snap;
+  std::string reply = hypr_request("[[BATCH]]j/clients;j/activeworkspace;j/monitors");
+  auto docs = split_json_values(reply);
+  if (docs.size() != 3) return snap;
+
+  bool ok = with_json_root(docs[0], [&](JsonNode* root) { snap.clients = parse_clients(root); });
+
+  ok = ok && with_json_root(docs[1], [&](JsonNode* root) {
+    if (!root || !JSON_NODE_HOLDS_OBJECT(root)) return;
+    const char* name = json_object_get_string_member(json_node_get_object(root), "name");
+    if (name) snap.active_workspace = name;
+  });
+
+  ok = ok && with_json_root(docs[2], [&](JsonNode* root) {
+    if (!root || !JSON_NODE_HOLDS_ARRAY(root)) return;
+    JsonArray* arr = json_node_get_array(root);
+    guint n = json_array_get_length(arr);
+    // Prefer the focused monitor's special workspace, like the last activespecial>> would
+    for (guint i = 0; i < n; i++) {
+      JsonObject* mon = json_array_get_object_element(arr, i);
+      if (!mon || !json_object_has_member(mon, "specialWorkspace")) continue;
+      JsonObject* sp = json_object_get_object_member(mon, "specialWorkspace");
+      const char* name = sp ? json_object_get_string_member(sp, "name") : nullptr;
+      if (!name || !*name) continue;
+      bool focused = json_object_has_member(mon, "focused") && json_object_get_boolean_member(mon, "focused");
+      if (focused || snap.active_special_workspace.empty()) snap.active_special_workspace = name;
+      if (focused) break;
+    }
+  });
+
+  snap.ok = ok;
+  return snap;
+}
+
+// ---------- state socket ----------
+// Process-wide hub serving the window/workspace state the module already tracks, so other
+// local tools need not poll hyprctl. Line protocol on a Unix socket, one JSON object per line:
+//   "snapshot\n"  -> {"seq":N,"type":"snapshot",...}
+//   "subscribe\n" -> the snapshot, then one line per change with increasing "seq"
+struct HubConn {
+  int fd = -1;
+  std::string in, out;
+  bool subscribed = false;
+  bool read_closed = false; // peer shut its write side; replies may still be owed
+  bool closed = false;
+};
+
+struct StateHub {
+  static constexpr size_t kMaxQueued = 1 << 20; // subscribers further behind are dropped
+
+  std::mutex mu; // guards everything below except `conns` (hub thread only)
+  // Instances using the hub. Only `owner` feeds it: each instance reads the event socket at
+  // its own pace, so mixing their updates would replay stale state as fake changes.
+  std::vector<const void*> users;
+  const void* owner = nullptr;
+  std::string path;
+  int listen_fd = -1;
+  int wake_fd = -1;
+  GThread* thread = nullptr;
+  std::atomic<bool> running{false};
+
+  uint64_t seq = 0;
+  std::vector<ClientInfo> clients;
+  std::string active_workspace, active_special_workspace;
+  std::vector<std::string> pending; // change lines not yet handed to subscribers
+
+  std::vector<HubConn> conns;
+};
+
+static StateHub g_hub;
+
+static std::string client_json(const ClientInfo& c) {
+  char ws_id[32]; snprintf(ws_id, sizeof(ws_id), "%d", c.workspace_id);
+  return "{\"address\":\"" + json_escape(c.address) + "\",\"class\":\"" + json_escape(c.cls) +
+         "\",\"title\":\"" + json_escape(c.title) + "\",\"workspace\":{\"id\":" + ws_id +
+         ",\"name\":\"" + json_escape(c.workspace_name) + "\"}}";
+}
+
+// Queues one change line (caller holds g_hub.mu)
+static void hub_emit_locked(const char* type, const std::string& body) {
+  g_hub.seq++;
+  g_hub.pending.push_back("{\"seq\":" + std::to_string(g_hub.seq) + ",\"type\":\"" + type + "\"," + body + "}\n");
+}
+
+static void hub_wake() {
+  uint64_t one = 1;
+  if (g_hub.wake_fd >= 0 && write(g_hub.wake_fd, &one, sizeof(one)) < 0) { /* counter saturated: already awake */ }
+}
+
+static std::string hub_snapshot_locked() {
+  std::string out = "{\"seq\":" + std::to_string(g_hub.seq) + ",\"type\":\"snapshot\",\"active_workspace\":\"" +
+                    json_escape(g_hub.active_workspace) + "\",\"active_special_workspace\":\"" +
+                    json_escape(g_hub.active_special_workspace) + "\",\"clients\":[";
+  for (size_t i = 0; i < g_hub.clients.size(); i++) {
+    if (i) out += ',';
+    out += client_json(g_hub.clients[i]);
+  }
+  out += "]}\n";
   return out;
 }
 
+// Diffs a fresh full client list against the served one and emits per-window changes
+static void hub_update_clients(const void* src, const std::vector<ClientInfo>& all) {
+  if (!g_hub.running.load(std::memory_order_relaxed)) return;
+  std::lock_guard<std::mutex> lk(g_hub.mu);
+  if (src != g_hub.owner) return;
+
+  std::unordered_map<std::string, const ClientInfo*> old;
+  for (const auto& c : g_hub.clients) old.emplace(c.address, &c);
+
+  size_t before = g_hub.pending.size();
+  for (const auto& c : all) {
+    auto it = old.find(c.address);
+    if (it == old.end()) {
+      hub_emit_locked("window_added", "\"client\":" + client_json(c));
+      continue;
+    }
+    const ClientInfo& o = *it->second;
+    if (o.cls != c.cls || o.title != c.title || o.workspace_id != c.workspace_id ||
+        o.workspace_name != c.workspace_name) {
+      hub_emit_locked("window_changed", "\"client\":" + client_json(c));
+    }
+    old.erase(it);
+  }
+  for (const auto& [address, c] : old) {
+    hub_emit_locked("window_removed", "\"address\":\"" + json_escape(address) + "\"");
+  }
+
+  g_hub.clients = all;
+  if (g_hub.pending.size() != before) hub_wake();
+}
+
+// Applies a windowtitlev2>> event directly, since titles alone never trigger a render
+static void hub_update_title(const void* src, std::string address, const std::string& title) {
+  if (!g_hub.running.load(std::memory_order_relaxed)) return;
+  if (!starts_with(address, "0x")) address = "0x" + address; // events omit the prefix j/clients uses
+  std::lock_guard<std::mutex> lk(g_hub.mu);
+  if (src != g_hub.owner) return;
+  for (auto& c : g_hub.clients) {
+    if (c.address != address) continue;
+    if (c.title == title) return;
+    c.title = title;
+    hub_emit_locked("window_changed", "\"client\":" + client_json(c));
+    hub_wake();
+    return;
+  }
+}
+
+// Sets one workspace field (`type` names it in the change line); each event only touches its own
+static void hub_set_field(const void* src, std::string StateHub::*field, const char* type, const std::string& value) {
+  if (!g_hub.running.load(std::memory_order_relaxed)) return;
+  std::lock_guard<std::mutex> lk(g_hub.mu);
+  if (src != g_hub.owner || g_hub.*field == value) return;
+  g_hub.*field = value;
+  hub_emit_locked(type, "\"workspace\":\"" + json_escape(value) + "\"");
+  hub_wake();
+}
+
+static void hub_set_active_workspace(const void* src, const std::string& ws) {
+  hub_set_field(src, &StateHub::active_workspace, "active_workspace", ws);
+}
+
+static void hub_set_active_special(const void* src, const std::string& ws) {
+  hub_set_field(src, &StateHub::active_special_workspace, "active_special_workspace", ws);
+}
+
+// Hands queued change lines to subscribers (caller holds g_hub.mu)
+static void hub_deliver_locked() {
+  for (const auto& line : g_hub.pending) {
+    for (auto& c : g_hub.conns) {
+      if (!c.subscribed || c.closed) continue;
+      if (c.out.size() + line.size() > StateHub::kMaxQueued) { c.closed = true; continue; }
+      c.out += line;
+    }
+  }
+  g_hub.pending.clear();
+}
+
+static void hub_handle_line(HubConn& c, const std::string& cmd) {
+  std::lock_guard<std::mutex> lk(g_hub.mu);
+  if (cmd == "snapshot" || cmd == "subscribe") {
+    // Flush older changes first so a new subscriber's stream starts right after its snapshot
+    hub_deliver_locked();
+    c.out += hub_snapshot_locked();
+    if (cmd == "subscribe") c.subscribed = true;
+  } else if (!cmd.empty()) {
+    c.out += "{\"type\":\"error\",\"message\":\"unknown command: " + json_escape(cmd) + "\"}\n";
+  }
+}
+
+static gpointer hub_thread_fn(gpointer) {
+  std::vector<pollfd> fds;
+  while (g_hub.running.load()) {
+    fds.clear();
+    fds.push_back({g_hub.listen_fd, POLLIN, 0});
+    fds.push_back({g_hub.wake_fd, POLLIN, 0});
+    for (const auto& c : g_hub.conns) {
+      fds.push_back({c.fd, (short)((c.read_closed ? 0 : POLLIN) | (c.out.empty() ? 0 : POLLOUT)), 0});
+    }
+
+    if (poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    if (!g_hub.running.load()) break;
+
+    if (fds[1].revents & POLLIN) {
+      uint64_t n;
+      if (read(g_hub.wake_fd, &n, sizeof(n)) < 0) { /* spurious wakeup */ }
+      std::lock_guard<std::mutex> lk(g_hub.mu);
+      hub_deliver_locked();
+    }
+
+    // `conns` only grows below, after this loop, so it still lines up with `fds`
+    for (size_t i = 0; i < g_hub.conns.size(); i++) {
+      HubConn& c = g_hub.conns[i];
+      short rev = fds[i + 2].revents;
+      if (c.closed) continue;
+
+      if (rev & POLLIN) {
+        char buf[1024];
+        ssize_t n = read(c.fd, buf, sizeof(buf));
+        if (n == 0) {
+          // Half-close (e.g. `printf 'snapshot\n' | socat ...`): answer before closing
+          c.read_closed = true;
+        } else if (n < 0) {
+          if (errno != EAGAIN && errno != EWOULDBLOCK) { c.closed = true; continue; }
+        } else {
+          c.in.append(buf, buf + n);
+          size_t nl;
+          while ((nl = c.in.find('\n')) != std::string::npos) {
+            hub_handle_line(c, trim(c.in.substr(0, nl)));
+            c.in.erase(0, nl + 1);
+          }
+          if (c.in.size() > 4096) { c.closed = true; continue; } // not a command
+        }
+      }
+      if (rev & (POLLHUP | POLLERR)) { // peer fully gone: nothing more can be delivered
+        c.closed = true;
+        continue;
+      }
+
+      if (!c.out.empty()) {
+        // MSG_NOSIGNAL: a peer vanishing mid-write must not SIGPIPE all of Waybar
+        ssize_t n = send(c.fd, c.out.data(), c.out.size(), MSG_NOSIGNAL);
+        if (n > 0) c.out.erase(0, (size_t)n);
+        else if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK) c.closed = true; // EPIPE, ECONNRESET
+      }
+      // Subscribers may half-close and keep listening; others are done once answered
+      if (c.read_closed && c.out.empty() && !c.subscribed) c.closed = true;
+    }
+
+    for (size_t i = 0; i < g_hub.conns.size(); ) {
+      if (g_hub.conns[i].closed) {
+        close(g_hub.conns[i].fd);
+        g_hub.conns.erase(g_hub.conns.begin() + (long)i);
+      } else {
+        i++;
+      }
+    }
+
+    if (fds[0].revents & POLLIN) {
+      while (true) {
+        int cfd = accept4(g_hub.listen_fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (cfd < 0) break;
+        HubConn conn;
+        conn.fd = cfd;
+        g_hub.conns.push_back(std::move(conn));
+      }
+    }
+  }
+
+  for (auto& c : g_hub.conns) close(c.fd);
+  g_hub.conns.clear();
+  return nullptr;
+}
+
+// Starts the hub on first use; later instances just share it (first path wins)
+static void hub_acquire(const void* src, const std::string& path) {
+  std::lock_guard<std::mutex> lk(g_hub.mu);
+  g_hub.users.push_back(src);
+  if (!g_hub.owner) g_hub.owner = src;
+  if (g_hub.users.size() > 1) return;
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0) return;
+
+  sockaddr_un addr{};
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+  bool bound = bind(fd, (sockaddr*)&addr, sizeof(addr)) == 0;
+  if (!bound && errno == EADDRINUSE) {
+    // Replace a stale socket file, but never steal one another process is serving
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    bool live = probe >= 0 && connect(probe, (sockaddr*)&addr, sizeof(addr)) == 0;
+    if (probe >= 0) close(probe);
+    if (live) {
+      g_warning("hypr-ws-apps: state socket %s is already served by another process", path.c_str());
+      close(fd);
+      return;
+    }
+    unlink(path.c_str());
+    bound = bind(fd, (sockaddr*)&addr, sizeof(addr)) == 0;
+  }
+  if (!bound || listen(fd, 8) != 0) {
+    g_warning("hypr-ws-apps: cannot listen on state socket %s", path.c_str());
+    close(fd);
+    return;
+  }
+
+  g_hub.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (g_hub.wake_fd < 0) {
+    close(fd);
+    unlink(path.c_str());
+    return;
+  }
+
+  g_hub.path = path;
+  g_hub.listen_fd = fd;
+  g_hub.running.store(true);
+  g_hub.thread = g_thread_new("hypr-ws-apps-hub", hub_thread_fn, nullptr);
+}
+
+static void hub_release(const void* src) {
+  GThread* thread = nullptr;
+  {
+    std::lock_guard<std::mutex> lk(g_hub.mu);
+    std::erase(g_hub.users, src);
+    // Hand feeding over; the new owner's next render re-diffs the full list, so it converges
+    if (g_hub.owner == src) g_hub.owner = g_hub.users.empty() ? nullptr : g_hub.users.front();
+    if (!g_hub.users.empty() || !g_hub.thread) return;
+    g_hub.running.store(false);
+    hub_wake();
+    thread = g_hub.thread;
+    g_hub.thread = nullptr;
+  }
+  g_thread_join(thread);
+
+  std::lock_guard<std::mutex> lk(g_hub.mu);
+  close(g_hub.listen_fd);
+  close(g_hub.wake_fd);
+  unlink(g_hub.path.c_str());
+  g_hub.listen_fd = g_hub.wake_fd = -1;
+  g_hub.seq = 0;
+  g_hub.clients.clear();
+  g_hub.active_workspace.clear();
+  g_hub.active_special_workspace.clear();
+  g_hub.pending.clear();
+}
+
 // ---------- config parsing from entries ----------
 static std::optional<std::string> config_get_json_string(const wbcffi_config_entry* entries,
                                                         size_t len,
@@ -311,10 +1109,33 @@ static std::optional<std::string> parse_string_loose(const std::string& raw) {
   return s;
 }
 
+// ---------- actions ----------
+enum class Action { None, Focus, Toggle, Pull, CycleNext, CyclePrev };
+
+static std::optional<Action> parse_action(const std::string& raw) {
+  std::string s = lower_ascii(unquote(strip_jsonc_comment(raw)));
+  if (s.empty() || s == "none") return Action::None;
+  if (s == "focus") return Action::Focus;
+  if (s == "toggle") return Action::Toggle;
+  if (s == "pull") return Action::Pull;
+  if (s == "cycle-next") return Action::CycleNext;
+  if (s == "cycle-prev") return Action::CyclePrev;
+  return std::nullopt;
+}
+
+// Workspace selector as understood by dispatchers: ids and special:<name> as-is, others by name
+static std::string workspace_selector(const std::string& ws) {
+  if (ws.empty()) return "+0";
+  if (starts_with(ws, "special:")) return ws;
+  bool numeric = ws.find_first_not_of("-0123456789") == std::string::npos;
+  return numeric ? ws : "name:" + ws;
+}
+
 // ---------- module state ----------
 struct ModuleState {
   GtkContainer* root = nullptr;
   GtkWidget* box = nullptr;
+  GtkWidget* events = nullptr;
   GtkWidget* wrapper = nullptr;
   GtkWidget* icons = nullptr;
   wbcffi_module* module = nullptr;
@@ -326,39 +1147,100 @@ struct ModuleState {
   int max_icons = 0;
   bool show_empty = false;
   bool tooltip = true;
+  bool show_count = false;
   std::string css_class;
+  std::string state_socket; // serve state on this Unix socket path, empty = off
+  Action on_click = Action::None;
+  Action on_click_middle = Action::None;
+  Action on_click_right = Action::None;
+  Action on_scroll_up = Action::None;
+  Action on_scroll_down = Action::None;
   std::string active_workspace;         // from workspace>> (normal workspaces)
   std::string active_special_workspace; // from activespecial>> (special workspaces)
-  std::mutex workspace_mu;
+  std::optional<std::vector<ClientInfo>> bootstrap_clients; // from fetch_snapshot(), used by the next render
+  std::mutex workspace_mu;                 // guards the three above
 
   std::atomic<bool> stop{false};
   std::atomic<int> socket_fd{-1};
   GThread* thread = nullptr;
 
-  IconResolver resolver;
   std::vector<std::string> last_classes;
+  std::vector<GtkWidget*> icon_images;   // per entry in last_classes
+  std::vector<GtkWidget*> count_labels;  // per entry in last_classes, null without show_count
+  std::vector<int> last_counts;          // per entry in last_classes
+  std::vector<ClientInfo> last_clients; // action targets, refreshed on every render
+  size_t cycle_index = 0;
+  double scroll_accum = 0.0;
 
   // simple coalescing: avoid queuing thousands of invokes
   std::atomic<bool> update_pending{false};
+
+  int trace_label = -1;
+  int trace_signal = -1; // write the trace on SIGRTMIN+trace_signal, -1 = only on deinit
+  std::atomic<gint64> update_queued_at{0}; // µs, for the "coalescing wait" span
 };
 
+static gboolean on_icon_button_press(GtkWidget* widget, GdkEventButton* ev, gpointer data);
+
+// Applies window counts to the existing icons: only entries whose count changed are touched
+static void update_count_badges(ModuleState* st, const std::vector<int>& counts) {
+  if (counts.size() != st->icon_images.size()) return;
+  if (st->last_counts.size() != counts.size()) st->last_counts.assign(counts.size(), 0);
+
+  for (size_t i = 0; i < counts.size(); i++) {
+    const int count = counts[i];
+    const int prev = st->last_counts[i];
+    if (count == prev) continue;
+    st->last_counts[i] = count;
+
+    if ((count > 1) != (prev > 1)) {
+      GtkStyleContext* ctx = gtk_widget_get_style_context(st->icon_images[i]);
+      if (count > 1) gtk_style_context_add_class(ctx, "multi");
+      else gtk_style_context_remove_class(ctx, "multi");
+    }
+
+    GtkWidget* label = st->count_labels[i];
+    if (!label) continue;
+    if (count > 1) {
+      gtk_label_set_text(GTK_LABEL(label), std::to_string(count).c_str());
+      if (prev <= 1) gtk_widget_show(label);
+    } else if (prev > 1) {
+      gtk_widget_hide(label);
+    }
+  }
+}
+
 static void render_icons(ModuleState* st) {
-  auto clients = clients_in_workspace(st->workspace);
+  TraceSpan span("render_icons");
+  std::optional<std::vector<ClientInfo>> all;
+  {
+    std::lock_guard<std::mutex> lk(st->workspace_mu);
+    all.swap(st->bootstrap_clients);
+  }
+  if (!all) all = fetch_clients();
+  if (all) hub_update_clients(st, *all);
+  else all.emplace();
+
+  auto clients = clients_in_workspace(*all, st->workspace);
+  st->last_clients = clients;
 
   std::vector<std::string> classes;
+  std::vector<int> counts; // windows per entry in `classes`
   std::vector<std::string> tooltip_lines;
-  std::unordered_map<std::string, bool> seen;
+  std::unordered_map<std::string, size_t> seen; // class -> index in `classes`
 
   for (auto& c : clients) {
     if (c.cls.empty()) continue;
-    if (seen[c.cls]) continue;
-    seen[c.cls] = true;
+    auto it = seen.find(c.cls);
+    if (it != seen.end()) { counts[it->second]++; continue; }
+    if (st->max_icons > 0 && (int)classes.size() >= st->max_icons) continue; // keep counting shown ones
 
+    seen.emplace(c.cls, classes.size());
     classes.push_back(c.cls);
+    counts.push_back(1);
     if (st->tooltip) {
       tooltip_lines.push_back(c.title.empty() ? c.cls : (c.cls + " — " + c.title));
     }
-    if (st->max_icons > 0 && (int)classes.size() >= st->max_icons) break;
   }
 
   const bool is_empty = classes.empty();
@@ -397,12 +1279,22 @@ static void render_icons(ModuleState* st) {
   apply_active_classes(st->box);
 
 
-  if (classes == st->last_classes) return;
+  // Same apps as before: only window counts may have moved, touch just those badges
+  if (classes == st->last_classes) {
+    TraceSpan reconcile("widget reconciliation");
+    update_count_badges(st, counts);
+    return;
+  }
   st->last_classes = classes;
 
+  TraceSpan reconcile("widget reconciliation");
+
   GList* children = gtk_container_get_children(GTK_CONTAINER(st->icons));
   for (GList* l = children; l != nullptr; l = l->next) gtk_widget_destroy(GTK_WIDGET(l->data));
   g_list_free(children);
+  st->icon_images.clear();
+  st->count_labels.clear();
+  st->last_counts.assign(classes.size(), 0);
 
 
   GtkIconTheme* theme = gtk_icon_theme_get_default();
@@ -410,14 +1302,17 @@ static void render_icons(ModuleState* st) {
   for (size_t idx = 0; idx < classes.size(); idx++) {
     const auto& cls = classes[idx];
 
-    auto icon = st->resolver.resolve_icon_for_class(cls);
+    std::optional<std::string> icon;
+    {
+      TraceSpan resolve("icon resolution");
+      icon = shared_resolver().resolve_icon_for_class(cls);
+    }
     GtkWidget* img = nullptr;
 
     if (icon && !icon->empty()) {
-      if ((*icon)[0] == '/' || starts_with(*icon, "file://")) {
-        std::string p = *icon;
-        if (starts_with(p, "file://")) p = p.substr(7);
-        GdkPixbuf* pb = gdk_pixbuf_new_from_file_at_scale(p.c_str(), st->icon_size, st->icon_size, TRUE, nullptr);
+      std::string p = icon_file_path(*icon);
+      if (!p.empty()) {
+        GdkPixbuf* pb = shared_resolver().load_pixbuf(p, st->icon_size);
         if (pb) { img = gtk_image_new_from_pixbuf(pb); g_object_unref(pb); }
       } else if (gtk_icon_theme_has_icon(theme, icon->c_str())) {
         img = gtk_image_new_from_icon_name(icon->c_str(), GTK_ICON_SIZE_MENU);
@@ -430,14 +1325,41 @@ static void render_icons(ModuleState* st) {
       gtk_image_set_pixel_size(GTK_IMAGE(img), st->icon_size);
     }
 
-    gtk_widget_set_margin_end(img, (idx + 1 < classes.size()) ? st->spacing : 0);
-    gtk_box_pack_start(GTK_BOX(st->icons), img, FALSE, FALSE, 0);
+    // Event box per icon so clicks know which app they target
+    GtkWidget* ev = gtk_event_box_new();
+    gtk_event_box_set_visible_window(GTK_EVENT_BOX(ev), FALSE);
+    g_object_set_data_full(G_OBJECT(ev), "hypr-ws-apps-class", g_strdup(cls.c_str()), g_free);
+    g_signal_connect(ev, "button-press-event", G_CALLBACK(on_icon_button_press), st);
+
+    GtkWidget* label = nullptr;
+    if (st->show_count) {
+      // Badge overlaid on the icon's bottom-right corner; text/visibility set below
+      GtkWidget* overlay = gtk_overlay_new();
+      gtk_container_add(GTK_CONTAINER(overlay), img);
+      label = gtk_label_new(nullptr);
+      gtk_widget_set_halign(label, GTK_ALIGN_END);
+      gtk_widget_set_valign(label, GTK_ALIGN_END);
+      gtk_style_context_add_class(gtk_widget_get_style_context(label), "hypr-ws-apps-count");
+      gtk_overlay_add_overlay(GTK_OVERLAY(overlay), label);
+      gtk_container_add(GTK_CONTAINER(ev), overlay);
+      gtk_widget_show(overlay);
+    } else {
+      gtk_container_add(GTK_CONTAINER(ev), img);
+    }
+    st->icon_images.push_back(img);
+    st->count_labels.push_back(label);
+
+    gtk_widget_set_margin_end(ev, (idx + 1 < classes.size()) ? st->spacing : 0);
+    gtk_box_pack_start(GTK_BOX(st->icons), ev, FALSE, FALSE, 0);
     gtk_widget_show(img);
+    gtk_widget_show(ev);
 
     GtkStyleContext* img_ctx = gtk_widget_get_style_context(img);
     gtk_style_context_add_class(img_ctx, "hypr-ws-apps-icon");
   }
 
+  update_count_badges(st, counts);
+
   if (st->tooltip) {
     std::string tip;
     for (size_t i = 0; i < tooltip_lines.size(); i++) {
@@ -458,9 +1380,114 @@ static void request_update(ModuleState* st) {
     st->update_pending.store(false);
     return;
   }
+  if (g_tracer.enabled.load(std::memory_order_relaxed)) st->update_queued_at.store(g_get_monotonic_time());
   st->queue_update(st->module);
 }
 
+// Builds the dispatchers for one action and sends them as a single batch.
+// `cls` narrows the target to the clicked icon's app; empty means the whole workspace.
+static void run_action(ModuleState* st, Action action, const std::string& cls) {
+  if (action == Action::None) return;
+  TraceLabelScope label(st->trace_label);
+  TraceSpan span("action");
+
+  const bool is_special_target = starts_with(st->workspace, "special:");
+  bool special_shown;
+  std::string active_workspace;
+  {
+    std::lock_guard<std::mutex> lk(st->workspace_mu);
+    special_shown = is_special_target && st->active_special_workspace == st->workspace;
+    active_workspace = st->active_workspace;
+  }
+  const std::string special_name = is_special_target ? st->workspace.substr(strlen("special:")) : "";
+
+  std::vector<const ClientInfo*> targets;
+  for (const auto& c : st->last_clients) {
+    if (c.address.empty()) continue;
+    if (cls.empty() || c.cls == cls) targets.push_back(&c);
+  }
+
+  std::vector<std::string> dispatches;
+  auto focus = [&](const ClientInfo* c) {
+    // A window on a hidden special workspace is only reachable once the workspace is shown
+    if (is_special_target && !special_shown) dispatches.push_back("togglespecialworkspace " + special_name);
+    dispatches.push_back("focuswindow address:" + c->address);
+  };
+
+  switch (action) {
+    case Action::Toggle:
+      if (is_special_target) dispatches.push_back("togglespecialworkspace " + special_name);
+      else dispatches.push_back("workspace " + workspace_selector(st->workspace));
+      break;
+    case Action::Focus:
+      if (!targets.empty()) focus(targets.front());
+      break;
+    case Action::Pull:
+      if (targets.empty()) break;
+      if (special_shown) dispatches.push_back("togglespecialworkspace " + special_name);
+      dispatches.push_back("movetoworkspace " + workspace_selector(active_workspace) + ",address:" +
+                           targets.front()->address);
+      break;
+    case Action::CycleNext:
+    case Action::CyclePrev: {
+      if (targets.empty()) break;
+      size_t n = targets.size();
+      st->cycle_index = (action == Action::CycleNext) ? (st->cycle_index + 1) % n
+                                                      : (st->cycle_index + n - 1) % n;
+      focus(targets[st->cycle_index % n]);
+      break;
+    }
+    case Action::None:
+      break;
+  }
+
+  hypr_dispatch_batch(dispatches);
+}
+
+static gboolean on_icon_button_press(GtkWidget* widget, GdkEventButton* ev, gpointer data) {
+  auto* st = (ModuleState*)data;
+  if (ev->type != GDK_BUTTON_PRESS) return FALSE;
+
+  Action action = Action::None;
+  if (ev->button == 1) action = st->on_click;
+  else if (ev->button == 2) action = st->on_click_middle;
+  else if (ev->button == 3) action = st->on_click_right;
+  if (action == Action::None) return FALSE; // let Waybar's own on-click handle it
+
+  auto* cls = (const char*)g_object_get_data(G_OBJECT(widget), "hypr-ws-apps-class");
+  run_action(st, action, cls ? cls : "");
+  return TRUE;
+}
+
+static gboolean on_scroll(GtkWidget*, GdkEventScroll* ev, gpointer data) {
+  auto* st = (ModuleState*)data;
+  if (st->on_scroll_up == Action::None && st->on_scroll_down == Action::None) return FALSE;
+
+  auto action_for = [&](double d) { return d < 0 ? st->on_scroll_up : st->on_scroll_down; };
+
+  // Scrolls without an action of ours (other direction, horizontal) go on to Waybar
+  int dir = 0;
+  if (ev->direction == GDK_SCROLL_UP) dir = -1;
+  else if (ev->direction == GDK_SCROLL_DOWN) dir = 1;
+  else if (ev->direction == GDK_SCROLL_SMOOTH) {
+    // Touchpads send many small deltas; act once per whole step
+    gdouble dx = 0, dy = 0;
+    gdk_event_get_scroll_deltas((const GdkEvent*)ev, &dx, &dy);
+    if (dy == 0 || action_for(dy) == Action::None) return FALSE;
+    if ((dy < 0) != (st->scroll_accum < 0)) st->scroll_accum = 0; // direction flipped
+    st->scroll_accum += dy;
+    if (st->scroll_accum <= -1.0) { dir = -1; st->scroll_accum = 0; }
+    else if (st->scroll_accum >= 1.0) { dir = 1; st->scroll_accum = 0; }
+    else return TRUE; // still accumulating towards a step of ours
+  }
+  if (dir == 0) return FALSE;
+
+  Action action = action_for(dir);
+  if (action == Action::None) return FALSE;
+  run_action(st, action, "");
+  return TRUE;
+}
+
 static std::string first_field(std::string s) {
   s = trim(std::move(s));
   auto pos = s.find(',');
@@ -475,86 +1502,144 @@ static std::string normalize_special_name(std::string s) {
   return "special:" + s;                      // add prefix
 }
 
-// thread: listen hypr events
-static gpointer hypr_thread_fn(gpointer data) {
-  auto* st = (ModuleState*)data;
+// Seeds active workspace state and the client list from one batched query
+static void bootstrap_state(ModuleState* st) {
+  HyprSnapshot snap = fetch_snapshot();
+  if (snap.ok) {
+    // Warm icons for every running app, not just this workspace's: any of them may move here
+    for (const auto& c : snap.clients) shared_resolver().prefetch(c.cls, st->icon_size, st->trace_label);
+    hub_update_clients(st, snap.clients);
+    hub_set_active_workspace(st, snap.active_workspace);
+    hub_set_active_special(st, snap.active_special_workspace);
 
-  std::string runtime = getenv_str("XDG_RUNTIME_DIR");
-  std::string sig = getenv_str("HYPRLAND_INSTANCE_SIGNATURE");
-  if (runtime.empty() || sig.empty()) return nullptr;
+    std::lock_guard<std::mutex> lk(st->workspace_mu);
+    st->active_workspace = std::move(snap.active_workspace);
+    st->active_special_workspace = std::move(snap.active_special_workspace);
+    st->bootstrap_clients = std::move(snap.clients);
+  }
+  request_update(st);
+}
 
-  std::string sock_path = runtime + "/hypr/" + sig + "/.socket2.sock";
+// Sleeps in short slices so deinit never waits on a full backoff
+static void sleep_unless_stopped(ModuleState* st, gulong usec) {
+  for (gulong slept = 0; slept < usec && !st->stop.load(); slept += 100000) g_usleep(100000);
+}
 
-  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
-  if (fd < 0) return nullptr;
-  st->socket_fd.store(fd);
+// thread: listen hypr events, reconnecting (and re-bootstrapping) if Hyprland drops the socket
+static gpointer hypr_thread_fn(gpointer data) {
+  auto* st = (ModuleState*)data;
+  TraceLabelScope label(st->trace_label);
 
-  if (st->stop.load()) {
-    close(fd);
-    st->socket_fd.store(-1);
-    return nullptr;
-  }
+  std::string sock_path = hypr_socket_path(".socket2.sock");
+  if (sock_path.empty()) { request_update(st); return nullptr; }
 
-  sockaddr_un addr{};
-  addr.sun_family = AF_UNIX;
-  strncpy(addr.sun_path, sock_path.c_str(), sizeof(addr.sun_path) - 1);
+  gulong backoff = 250000;
+  while (!st->stop.load()) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) { request_update(st); return nullptr; }
+    st->socket_fd.store(fd);
+
+    if (st->stop.load()) break;
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, sock_path.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+      close(fd);
+      st->socket_fd.store(-1);
+      // No bootstrap to render from: still apply empty/inactive classes and show_empty
+      request_update(st);
+      sleep_unless_stopped(st, backoff);
+      backoff = std::min<gulong>(backoff * 2, 5000000);
+      continue;
+    }
+    backoff = 250000;
 
-  if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
-    close(fd);
-    st->socket_fd.store(-1);
-    return nullptr;
-  }
+    // Subscribe first, then snapshot: an event racing the query only triggers a redundant render
+    bootstrap_state(st);
 
-  request_update(st);
+    std::string buf;
+    buf.reserve(4096);
+    char tmp[1024];
 
-  std::string buf;
-  buf.reserve(4096);
-  char tmp[1024];
+    while (!st->stop.load()) {
+      // Wait outside the span so it measures the read, not the idle time between events
+      pollfd pfd{fd, POLLIN, 0};
+      if (poll(&pfd, 1, -1) < 0) {
+        if (errno == EINTR) continue;
+        break;
+      }
+      ssize_t n;
+      {
+        TraceSpan read_span("socket read");
+        n = read(fd, tmp, sizeof(tmp));
+      }
+      if (n <= 0) break;
+      buf.append(tmp, tmp + n);
+
+      size_t pos = 0;
+      while (true) {
+        size_t nl = buf.find('\n', pos);
+        if (nl == std::string::npos) { buf.erase(0, pos); break; }
+        std::string line = buf.substr(pos, nl - pos);
+        pos = nl + 1;
+        TraceSpan dispatch_span("event dispatch");
+
+        if (starts_with(line, "workspace>>")) {
+          {
+            std::lock_guard<std::mutex> lk(st->workspace_mu);
+            st->active_workspace = first_field(line.substr(strlen("workspace>>")));
+            hub_set_active_workspace(st, st->active_workspace);
+          }
+          request_update(st);
+          continue;
+        }
 
-  while (!st->stop.load()) {
-    ssize_t n = read(fd, tmp, sizeof(tmp));
-    if (n <= 0) break;
-    buf.append(tmp, tmp + n);
-
-    size_t pos = 0;
-    while (true) {
-      size_t nl = buf.find('\n', pos);
-      if (nl == std::string::npos) { buf.erase(0, pos); break; }
-      std::string line = buf.substr(pos, nl - pos);
-      pos = nl + 1;
-
-      if (starts_with(line, "workspace>>")) {
-        {
-          std::lock_guard<std::mutex> lk(st->workspace_mu);
-          st->active_workspace = first_field(line.substr(strlen("workspace>>")));
+        if (starts_with(line, "activespecial>>")) {
+          {
+            std::lock_guard<std::mutex> lk(st->workspace_mu);
+            st->active_special_workspace = normalize_special_name(
+              line.substr(strlen("activespecial>>"))
+            );
+            hub_set_active_special(st, st->active_special_workspace);
+          }
+          request_update(st);
+          continue;
         }
-        request_update(st);
-        continue;
-      }
 
-      if (starts_with(line, "activespecial>>")) {
-        {
-          std::lock_guard<std::mutex> lk(st->workspace_mu);
-          st->active_special_workspace = normalize_special_name(
-            line.substr(strlen("activespecial>>"))
-          );
+        if (starts_with(line, "windowtitlev2>>")) {
+          // windowtitlev2>>ADDRESS,TITLE
+          std::string rest = line.substr(strlen("windowtitlev2>>"));
+          size_t comma = rest.find(',');
+          if (comma != std::string::npos) hub_update_title(st, rest.substr(0, comma), rest.substr(comma + 1));
+          continue;
+        }
+
+        if (starts_with(line, "openwindow>>")) {
+          // openwindow>>ADDRESS,WORKSPACENAME,CLASS,TITLE
+          size_t a = line.find(',');
+          size_t b = (a == std::string::npos) ? a : line.find(',', a + 1);
+          size_t c = (b == std::string::npos) ? b : line.find(',', b + 1);
+          if (c != std::string::npos) shared_resolver().prefetch(line.substr(b + 1, c - b - 1), st->icon_size, st->trace_label);
         }
-        request_update(st);
-        continue;
-      }
 
-      if (starts_with(line, "openwindow>>") ||
-          starts_with(line, "closewindow>>") ||
-          starts_with(line, "movewindow>>") ||
-          starts_with(line, "createworkspace>>") ||
-          starts_with(line, "destroyworkspace>>")) {
-        request_update(st);
+        if (starts_with(line, "openwindow>>") ||
+            starts_with(line, "closewindow>>") ||
+            starts_with(line, "movewindow>>") ||
+            starts_with(line, "createworkspace>>") ||
+            starts_with(line, "destroyworkspace>>")) {
+          request_update(st);
+        }
       }
     }
+
+    close(fd);
+    st->socket_fd.store(-1);
   }
 
-  close(fd);
-  st->socket_fd.store(-1);
+  int fd = st->socket_fd.exchange(-1);
+  if (fd >= 0) close(fd);
   return nullptr;
 }
 
@@ -578,6 +1663,7 @@ extern "C" void* wbcffi_init(const wbcffi_init_info* init_info,
 
   st->root = init_info->get_root_widget(init_info->obj);
   if (!st->root) { delete st; return nullptr; }
+  shared_resolver().acquire();
 
   // config
   if (auto v = config_get_json_string(config_entries, config_entries_len, "workspace")) {
@@ -598,9 +1684,42 @@ extern "C" void* wbcffi_init(const wbcffi_init_info* init_info,
   if (auto v = config_get_json_string(config_entries, config_entries_len, "tooltip")) {
     if (auto b = parse_bool_loose(*v)) st->tooltip = *b;
   }
+  if (auto v = config_get_json_string(config_entries, config_entries_len, "show_count")) {
+    if (auto b = parse_bool_loose(*v)) st->show_count = *b;
+  }
   if (auto v = config_get_json_string(config_entries, config_entries_len, "css_class")) {
     if (auto s = parse_string_loose(*v)) st->css_class = *s;
   }
+  std::string trace_file = getenv_str("HYPR_WS_APPS_TRACE");
+  if (auto v = config_get_json_string(config_entries, config_entries_len, "trace_file")) {
+    if (auto s = parse_string_loose(*v)) trace_file = *s;
+  }
+  if (!trace_file.empty()) trace_enable(trace_file);
+  if (auto v = config_get_json_string(config_entries, config_entries_len, "trace_signal")) {
+    if (auto i = parse_int_loose(*v)) st->trace_signal = *i;
+  }
+  if (auto v = config_get_json_string(config_entries, config_entries_len, "state_socket")) {
+    if (auto b = parse_bool_loose(*v)) {
+      std::string runtime = getenv_str("XDG_RUNTIME_DIR");
+      if (*b && !runtime.empty()) st->state_socket = runtime + "/hypr-ws-apps.sock";
+    } else if (auto s = parse_string_loose(*v)) {
+      st->state_socket = *s;
+    }
+  }
+  st->trace_label = trace_register_label(st->css_class.empty() ? st->workspace : st->css_class, st->workspace);
+  const std::pair<const char*, Action*> action_keys[] = {
+    {"on_click", &st->on_click},
+    {"on_click_middle", &st->on_click_middle},
+    {"on_click_right", &st->on_click_right},
+    {"on_scroll_up", &st->on_scroll_up},
+    {"on_scroll_down", &st->on_scroll_down},
+  };
+  for (const auto& [key, dst] : action_keys) {
+    if (auto v = config_get_json_string(config_entries, config_entries_len, key)) {
+      if (auto a = parse_action(*v)) *dst = *a;
+      else g_warning("hypr-ws-apps: unknown action for %s: %s", key, v->c_str());
+    }
+  }
 
   // UI: wrapper (stylable) -> row (icons)
   st->wrapper = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 0);
@@ -644,16 +1763,24 @@ extern "C" void* wbcffi_init(const wbcffi_init_info* init_info,
   gtk_widget_set_halign(st->box, GTK_ALIGN_CENTER);
 
   gtk_box_pack_start(GTK_BOX(st->wrapper), st->box, TRUE, TRUE, 0);
-  gtk_container_add(GTK_CONTAINER(st->root), st->wrapper);
+
+  // Input-only event box around everything, for scroll actions
+  st->events = gtk_event_box_new();
+  gtk_event_box_set_visible_window(GTK_EVENT_BOX(st->events), FALSE);
+  gtk_widget_add_events(st->events, GDK_SCROLL_MASK | GDK_SMOOTH_SCROLL_MASK);
+  g_signal_connect(st->events, "scroll-event", G_CALLBACK(on_scroll), st);
+  gtk_container_add(GTK_CONTAINER(st->events), st->wrapper);
+  gtk_container_add(GTK_CONTAINER(st->root), st->events);
 
   gtk_widget_show(st->box);
   gtk_widget_show(st->wrapper);
+  gtk_widget_show(st->events);
 
-  // thread
-  st->thread = g_thread_new("hypr-ws-apps", hypr_thread_fn, st);
+  if (!st->state_socket.empty()) hub_acquire(st, st->state_socket);
 
-  // initial render
-  request_update(st);
+  // thread (performs the initial render: after the bootstrap snapshot, or at once if Hyprland
+  // cannot be reached)
+  st->thread = g_thread_new("hypr-ws-apps", hypr_thread_fn, st);
 
   return st;
 }
@@ -669,13 +1796,17 @@ extern "C" void wbcffi_deinit(void* instance) {
     g_thread_join(st->thread);
     st->thread = nullptr;
   }
+  if (!st->state_socket.empty()) hub_release(st);
+  shared_resolver().release();
 
-  if (st->wrapper) {
-    gtk_widget_destroy(st->wrapper);
+  if (st->events) {
+    gtk_widget_destroy(st->events);
+    st->events = nullptr;
     st->wrapper = nullptr;
     st->box = nullptr;
   }
   delete st;
+  trace_write();
 }
 
 // optional, safe no-op (Waybar may call it)
@@ -684,7 +1815,31 @@ extern "C" void wbcffi_update(void* instance) {
   if (!st) return;
   st->update_pending.store(false);
   if (st->stop.load()) return;
+
+  TraceLabelScope label(st->trace_label);
+  if (gint64 queued = st->update_queued_at.exchange(0)) {
+    trace_record("coalescing wait", queued, g_get_monotonic_time() - queued);
+  }
   render_icons(st);
 }
-extern "C" void wbcffi_refresh(void*, int) {}
-extern "C" void wbcffi_doaction(void*, const char*) {}
+
+// Waybar signal: re-query and redraw; on our own trace_signal also dump the trace so far
+// (Waybar forwards every real-time signal to every module, so others must not trigger it)
+extern "C" void wbcffi_refresh(void* instance, int signal) {
+  auto* st = (ModuleState*)instance;
+  if (!st) return;
+  if (st->trace_signal >= 0 && signal == SIGRTMIN + st->trace_signal) trace_write();
+  request_update(st);
+}
+
+// Waybar "actions" config, e.g. "actions": { "on-click-right": "toggle" }
+extern "C" void wbcffi_doaction(void* instance, const char* action_name) {
+  auto* st = (ModuleState*)instance;
+  if (!st || !action_name) return;
+  auto action = parse_action(action_name);
+  if (!action) {
+    g_warning("hypr-ws-apps: unknown action: %s", action_name);
+    return;
+  }
+  run_action(st, *action, "");
+}